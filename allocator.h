@@ -4,8 +4,19 @@
 
 #pragma once
 
+#include <vector>
+
 #include "chunk.h"
 
+enum class Policy {
+    BestFit,
+    WorstFit,
+    FirstFit,
+    NextFit,
+    Bitmap,
+    Region,
+};
+
 enum class ListOrder {
     InsertBack,
     InsertFront,
@@ -14,6 +25,14 @@ enum class ListOrder {
     SizeSortDesc,
 };
 
+// Everything an allocator needs to resume from where it stopped.
+struct AllocatorState {
+    std::vector<Chunk> freelist;  // free chunks in list order
+    size_t cursor;                // roving position, next-fit only
+    std::vector<Chunk> extents;   // extents mapped by the large-allocation bypass
+    std::vector<size_t> marks;    // open region marks
+};
+
 class Allocator {
    public:
     Allocator() = default;
@@ -22,8 +41,32 @@ class Allocator {
     virtual auto malloc(size_t size) -> Chunk = 0;
     virtual auto free(Chunk chunk) -> void = 0;
 
+    // Slide an allocated chunk down into the free space right below it,
+    // returns where it lives now, which is the chunk itself if it can't move.
+    virtual auto relocate(Chunk chunk) -> Chunk = 0;
+
+    // Whether there's nothing left to compact, i.e. relocate can't move anything.
+    virtual auto compacted() const -> bool = 0;
+
+    // Open a nested region. Releasing it frees everything allocated since,
+    // the caller passes in what is still live so general allocators can
+    // free it chunk by chunk, while region allocators just reset.
+    virtual auto mark() -> void {}
+    virtual auto release(const std::vector<Chunk>& live) -> void {
+        for (const auto& chunk : live) {
+            free(chunk);
+        }
+    }
+
     virtual auto last_searched() const -> size_t = 0;
+    virtual auto last_bypassed() const -> bool { return false; }  // served outside the heap
+    virtual auto fragmentation() const -> double = 0;
+    virtual auto chunk_metadata() const -> size_t = 0;  // bytes per free chunk
     virtual auto print_status() -> void = 0;
+    virtual auto print_search() const -> void {}  // how the last malloc searched
+
+    virtual auto save_state() const -> AllocatorState = 0;
+    virtual auto restore_state(const AllocatorState& state) -> void = 0;
 
    private:
     Allocator(const Allocator&) = delete;
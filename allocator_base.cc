@@ -5,10 +5,11 @@
 #include "allocator_base.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdio>
 
-// Currently we don't consider invalid chuck
-auto AllocatorBase::free(Chunk chunk) -> void {
+template <typename Offset>
+auto AllocatorBase<Offset>::insert(Entry chunk) -> void {
     switch (order_) {
         case ListOrder::InsertBack:
             freelist_.push_back(chunk);
@@ -18,26 +19,32 @@ auto AllocatorBase::free(Chunk chunk) -> void {
             break;
         case ListOrder::AddrSort: {
             auto it = std::lower_bound(freelist_.begin(), freelist_.end(), chunk,
-                                       [](const Chunk& a, const Chunk& c) {
+                                       [](const Entry& a, const Entry& c) {
                                            return a.base() < c.base();
                                        });
             freelist_.insert(it, chunk);
         } break;
         case ListOrder::SizeSortAsc: {
             auto it = std::lower_bound(freelist_.begin(), freelist_.end(), chunk,
-                                       [](const Chunk& a, const Chunk& c) {
+                                       [](const Entry& a, const Entry& c) {
                                            return a.size() < c.size();
                                        });
             freelist_.insert(it, chunk);
         } break;
         case ListOrder::SizeSortDesc: {
             auto it = std::lower_bound(freelist_.begin(), freelist_.end(), chunk,
-                                       [](const Chunk& a, const Chunk& c) {
+                                       [](const Entry& a, const Entry& c) {
                                            return a.size() > c.size();
                                        });
             freelist_.insert(it, chunk);
         }
     }
+}
+
+// Currently we don't consider invalid chuck
+template <typename Offset>
+auto AllocatorBase<Offset>::free(Chunk chunk) -> void {
+    insert(to_entry(chunk));
 
     if (coalesce_) {
         for (auto current = freelist_.begin(); current != freelist_.end(); ++current) {
@@ -61,10 +68,103 @@ auto AllocatorBase::free(Chunk chunk) -> void {
     }
 }
 
-auto AllocatorBase::print_status() -> void {
+// Free chunks around the moved one are always merged, otherwise
+// a run of uncoalesced free chunks would pin everything above it.
+// Neighbours are found by scanning the list, so a move is linear in its length.
+template <typename Offset>
+auto AllocatorBase<Offset>::relocate(Chunk chunk) -> Chunk {
+    auto ends_at = [this](size_t addr) {
+        return std::find_if(freelist_.begin(), freelist_.end(),
+                            [addr](const Entry& c) { return c.base() + c.size() == addr; });
+    };
+    auto starts_at = [this](size_t addr) {
+        return std::find_if(freelist_.begin(), freelist_.end(),
+                            [addr](const Entry& c) { return c.base() == addr; });
+    };
+
+    auto entry = to_entry(chunk);
+    auto below = ends_at(entry.base());
+    if (below == freelist_.end()) {
+        return chunk;
+    }
+
+    // gather all the free space right below the chunk
+    auto hole = *below;
+    freelist_.erase(below);
+    for (auto it = ends_at(hole.base()); it != freelist_.end(); it = ends_at(hole.base())) {
+        hole = Entry{it->base(), static_cast<Offset>(it->size() + hole.size())};
+        freelist_.erase(it);
+    }
+
+    // the hole moves above the chunk and joins the free space there
+    auto moved = to_chunk(hole.base(), entry.size());
+    hole = Entry{static_cast<Offset>(hole.base() + entry.size()), hole.size()};
+    for (auto it = starts_at(hole.base() + hole.size()); it != freelist_.end();
+         it = starts_at(hole.base() + hole.size())) {
+        hole.expand(it->size());
+        freelist_.erase(it);
+    }
+
+    insert(hole);
+    return moved;
+}
+
+// Compacted when all the free space is one chunk at the top of the heap.
+template <typename Offset>
+auto AllocatorBase<Offset>::compacted() const -> bool {
+    if (freelist_.empty()) {
+        return true;
+    }
+    const auto& chunk = freelist_.front();
+    return freelist_.size() == 1 && chunk.base() + chunk.size() == size_ / granule_;
+}
+
+// External fragmentation: the share of free space outside the largest free chunk
+template <typename Offset>
+auto AllocatorBase<Offset>::fragmentation() const -> double {
+    size_t total = 0;
+    size_t largest = 0;
+    for (const auto& chunk : freelist_) {
+        total += chunk.size();
+        largest = std::max<size_t>(largest, chunk.size());
+    }
+
+    return total == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / total;
+}
+
+// Each free chunk takes a list node, that is the entry plus two links.
+template <typename Offset>
+auto AllocatorBase<Offset>::chunk_metadata() const -> size_t {
+    return sizeof(Entry) + 2 * sizeof(void*);
+}
+
+template <typename Offset>
+auto AllocatorBase<Offset>::print_status() -> void {
     std::printf("Free List [ Size: %lu ]: ", freelist_.size());
-    for (auto& chunk : freelist_) {
+    for (auto& entry : freelist_) {
+        auto chunk = to_chunk(entry);
         std::printf("[ Base: %lu, Size: %lu ] ", chunk.base(), chunk.size());
     }
     std::puts("\n");
 }
+
+template <typename Offset>
+auto AllocatorBase<Offset>::save_state() const -> AllocatorState {
+    auto state = AllocatorState{{}, 0, {}, {}};
+    for (const auto& entry : freelist_) {
+        state.freelist.push_back(to_chunk(entry));
+    }
+    return state;
+}
+
+// The list is restored as-is, it's up to the caller to keep the order
+template <typename Offset>
+auto AllocatorBase<Offset>::restore_state(const AllocatorState& state) -> void {
+    freelist_.clear();
+    for (const auto& chunk : state.freelist) {
+        freelist_.push_back(to_entry(chunk));
+    }
+}
+
+template class AllocatorBase<size_t>;
+template class AllocatorBase<uint32_t>;
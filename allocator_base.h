@@ -8,27 +8,64 @@
 
 #include "allocator.h"
 
+// The free list keeps chunks as Offset-wide granule units from the heap base,
+// they're turned into addresses only when handed out.
+template <typename Offset>
 class AllocatorBase : public Allocator {
    public:
-    AllocatorBase(size_t base, size_t size, bool coalesce, ListOrder order)
-        : Allocator{}, base_{base}, size_{size}, coalesce_{coalesce}, order_{order}, searched_{0}, freelist_{} {
-        freelist_.emplace_front(base, size);
+    using Entry = BasicChunk<Offset>;
+
+    AllocatorBase(size_t base, size_t size, size_t granule, bool coalesce, ListOrder order)
+        : Allocator{},
+          base_{base},
+          size_{size},
+          granule_{granule},
+          coalesce_{coalesce},
+          order_{order},
+          searched_{0},
+          freelist_{} {
+        freelist_.emplace_front(0, size / granule);
     }
     virtual ~AllocatorBase() = default;
 
     virtual auto free(Chunk chunk) -> void override;
+    virtual auto relocate(Chunk chunk) -> Chunk override;
+    virtual auto compacted() const -> bool override;
 
     virtual auto last_searched() const -> size_t override { return searched_; }
+    virtual auto fragmentation() const -> double override;
+    virtual auto chunk_metadata() const -> size_t override;
     virtual auto print_status() -> void override;
 
+    virtual auto save_state() const -> AllocatorState override;
+    virtual auto restore_state(const AllocatorState& state) -> void override;
+
    protected:
+    // insert a free chunk at the position given by order_
+    auto insert(Entry entry) -> void;
+
+    // round size up to granule units
+    auto to_units(size_t size) const -> size_t { return (size + granule_ - 1) / granule_; }
+
+    auto to_entry(const Chunk& chunk) const -> Entry {
+        return Entry{static_cast<Offset>((chunk.base() - base_) / granule_),
+                     static_cast<Offset>(chunk.size() / granule_)};
+    }
+
+    auto to_chunk(size_t offset, size_t units) const -> Chunk {
+        return Chunk{base_ + offset * granule_, units * granule_};
+    }
+
+    auto to_chunk(const Entry& entry) const -> Chunk { return to_chunk(entry.base(), entry.size()); }
+
     const size_t base_;
     const size_t size_;
+    const size_t granule_;
     const bool coalesce_;
     const ListOrder order_;
 
     size_t searched_;
-    std::list<Chunk> freelist_;
+    std::list<Entry> freelist_;
 
    private:
     AllocatorBase(const AllocatorBase&) = delete;
@@ -4,8 +4,11 @@
 
 #include "allocator_best.h"
 
+#include <cstdint>
+
 // Find the smallest free chunk to fit the given size.
-auto AllocatorBest::malloc(size_t size) -> Chunk {
+template <typename Offset>
+auto AllocatorBest<Offset>::malloc(size_t size) -> Chunk {
     if (0 == size) {
         return Chunk{0, 0};  // {0, 0} as null
     }
@@ -13,13 +16,14 @@ auto AllocatorBest::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
     searched_ = 0;
+    auto units = to_units(size);
 
     // search for the smallest fit
     auto fit = freelist_.end();
     for (auto it = freelist_.begin(); it != freelist_.end(); ++it) {
         ++searched_;
 
-        if (it->size() >= size) {
+        if (it->size() >= units) {
             if (fit == freelist_.end()) {
                 fit = it;
             } else if (it->size() < fit->size()) {
@@ -30,13 +34,13 @@ auto AllocatorBest::malloc(size_t size) -> Chunk {
 
     if (fit != freelist_.end()) {
         // perfect fit
-        if (fit->size() == size) {
-            auto c = *fit;
+        if (fit->size() == units) {
+            auto c = to_chunk(*fit);
             freelist_.erase(fit);
             return c;
         } else {
-            Chunk c{fit->base(), size};
-            fit->shrink(size);
+            auto c = to_chunk(fit->base(), units);
+            fit->shrink(units);
             return c;
         }
     } else {
@@ -44,3 +48,6 @@ auto AllocatorBest::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
 }
+
+template class AllocatorBest<size_t>;
+template class AllocatorBest<uint32_t>;
@@ -6,15 +6,21 @@
 
 #include "allocator_base.h"
 
-class AllocatorBest : public AllocatorBase {
+template <typename Offset>
+class AllocatorBest : public AllocatorBase<Offset> {
    public:
-    AllocatorBest(size_t base, size_t size, bool coalesce, ListOrder order)
-        : AllocatorBase{base, size, coalesce, order} {};
+    AllocatorBest(size_t base, size_t size, size_t granule, bool coalesce, ListOrder order)
+        : AllocatorBase<Offset>{base, size, granule, coalesce, order} {};
     virtual ~AllocatorBest() = default;
 
     virtual auto malloc(size_t size) -> Chunk override;
 
    private:
+    using AllocatorBase<Offset>::to_chunk;
+    using AllocatorBase<Offset>::to_units;
+    using AllocatorBase<Offset>::searched_;
+    using AllocatorBase<Offset>::freelist_;
+
     AllocatorBest(const AllocatorBest&) = delete;
     AllocatorBest& operator=(const AllocatorBest&) = delete;
 };
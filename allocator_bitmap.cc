@@ -0,0 +1,232 @@
+// allocator_bitmap.cc
+// Bitmap allocator implementation
+// Author: Hank Bao
+
+#include "allocator_bitmap.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const size_t kWordBits = 64;
+const uint64_t kFull = ~uint64_t{0};
+
+// mask of bits [from, 64) within a word
+auto mask_from(size_t from) -> uint64_t {
+    return from >= kWordBits ? 0 : kFull << from;
+}
+
+}  // namespace
+
+AllocatorBitmap::AllocatorBitmap(size_t base, size_t size, size_t granule)
+    : Allocator{},
+      base_{base},
+      granule_{granule},
+      nbits_{size / granule},
+      words_{(size / granule + kWordBits - 1) / kWordBits},
+      searched_{0},
+      bits_(words_, 0),
+      full_((words_ + kWordBits - 1) / kWordBits, 0) {
+    // bits past the heap are never free
+    if (nbits_ % kWordBits != 0) {
+        bits_.back() = mask_from(nbits_ % kWordBits);
+        update_summary(words_ - 1);
+    }
+    // so are summary bits of words past the bitmap
+    if (words_ % kWordBits != 0) {
+        full_.back() |= mask_from(words_ % kWordBits);
+    }
+}
+
+// Find the first run of clear bits to fit the given size.
+auto AllocatorBitmap::malloc(size_t size) -> Chunk {
+    if (0 == size) {
+        return Chunk{0, 0};  // {0, 0} as null
+    }
+    searched_ = 0;
+
+    auto count = (size + granule_ - 1) / granule_;
+    for (auto pos = find_clear(0); pos < nbits_;) {
+        ++searched_;
+
+        auto end = find_set(pos);
+        if (end - pos >= count) {
+            set_range(pos, count);
+            return to_chunk(pos, count);
+        }
+        pos = find_clear(end);
+    }
+
+    // search failed
+    return Chunk{0, 0};
+}
+
+// Currently we don't consider invalid chuck
+auto AllocatorBitmap::free(Chunk chunk) -> void {
+    clear_range((chunk.base() - base_) / granule_, chunk.size() / granule_);
+}
+
+// Slide the chunk down over the clear bits right below it.
+auto AllocatorBitmap::relocate(Chunk chunk) -> Chunk {
+    auto pos = (chunk.base() - base_) / granule_;
+    auto count = chunk.size() / granule_;
+
+    // count clear bits below pos a word at a time
+    size_t below = 0;
+    while (below < pos) {
+        auto bit = pos - below - 1;
+        auto word = bits_[bit / kWordBits] << (kWordBits - 1 - bit % kWordBits);
+        if (word != 0) {
+            below += __builtin_clzll(word);
+            break;
+        }
+        below += bit % kWordBits + 1;
+    }
+
+    if (below == 0) {
+        return chunk;
+    }
+
+    clear_range(pos, count);
+    set_range(pos - below, count);
+    return to_chunk(pos - below, count);
+}
+
+// Compacted when the first clear bit starts a run to the top of the heap.
+auto AllocatorBitmap::compacted() const -> bool {
+    auto pos = find_clear(0);
+    return pos >= nbits_ || find_set(pos) == nbits_;
+}
+
+// External fragmentation: the share of free space outside the largest free run
+auto AllocatorBitmap::fragmentation() const -> double {
+    size_t total = 0;
+    for (auto word : bits_) {
+        total += kWordBits - __builtin_popcountll(word);
+    }
+
+    size_t largest = 0;
+    for (auto pos = find_clear(0); pos < nbits_;) {
+        auto end = find_set(pos);
+        largest = std::max(largest, end - pos);
+        pos = find_clear(end);
+    }
+
+    return total == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / total;
+}
+
+// The bitmap doesn't grow with free chunks, amortize it over the free runs.
+auto AllocatorBitmap::chunk_metadata() const -> size_t {
+    size_t runs = 0;
+    for (auto pos = find_clear(0); pos < nbits_; pos = find_clear(find_set(pos))) {
+        ++runs;
+    }
+
+    auto bytes = (bits_.size() + full_.size()) * sizeof(uint64_t);
+    return bytes / std::max<size_t>(runs, 1);
+}
+
+auto AllocatorBitmap::print_status() -> void {
+    auto state = save_state();
+    std::printf("Free Runs [ Size: %lu ]: ", state.freelist.size());
+    for (auto& chunk : state.freelist) {
+        std::printf("[ Base: %lu, Size: %lu ] ", chunk.base(), chunk.size());
+    }
+    std::puts("\n");
+}
+
+// Free runs are saved as a free list in address order.
+auto AllocatorBitmap::save_state() const -> AllocatorState {
+    auto state = AllocatorState{{}, 0, {}, {}};
+    for (auto pos = find_clear(0); pos < nbits_;) {
+        auto end = find_set(pos);
+        state.freelist.push_back(to_chunk(pos, end - pos));
+        pos = find_clear(end);
+    }
+    return state;
+}
+
+auto AllocatorBitmap::restore_state(const AllocatorState& state) -> void {
+    set_range(0, nbits_);
+    for (const auto& chunk : state.freelist) {
+        free(chunk);
+    }
+}
+
+auto AllocatorBitmap::find_clear(size_t pos) const -> size_t {
+    if (pos >= nbits_) {
+        return nbits_;
+    }
+
+    auto w = pos / kWordBits;
+    auto word = ~bits_[w] & mask_from(pos % kWordBits);
+    while (word == 0) {
+        w = find_nonfull(w + 1);
+        if (w >= words_) {
+            return nbits_;
+        }
+        word = ~bits_[w];
+    }
+
+    return w * kWordBits + __builtin_ctzll(word);
+}
+
+auto AllocatorBitmap::find_set(size_t pos) const -> size_t {
+    if (pos >= nbits_) {
+        return nbits_;
+    }
+
+    auto w = pos / kWordBits;
+    auto word = bits_[w] & mask_from(pos % kWordBits);
+    while (word == 0) {
+        if (++w >= words_) {
+            return nbits_;
+        }
+        word = bits_[w];
+    }
+
+    return std::min(nbits_, w * kWordBits + __builtin_ctzll(word));
+}
+
+auto AllocatorBitmap::find_nonfull(size_t w) const -> size_t {
+    while (w < words_) {
+        auto summary = ~full_[w / kWordBits] & mask_from(w % kWordBits);
+        if (summary != 0) {
+            return std::min(words_, w / kWordBits * kWordBits + __builtin_ctzll(summary));
+        }
+        w = (w / kWordBits + 1) * kWordBits;
+    }
+    return words_;
+}
+
+auto AllocatorBitmap::set_range(size_t pos, size_t count) -> void {
+    for (auto end = pos + count; pos < end;) {
+        auto w = pos / kWordBits;
+        auto bits = std::min(end - pos, kWordBits - pos % kWordBits);
+        auto mask = bits == kWordBits ? kFull : ((uint64_t{1} << bits) - 1) << (pos % kWordBits);
+        bits_[w] |= mask;
+        update_summary(w);
+        pos += bits;
+    }
+}
+
+auto AllocatorBitmap::clear_range(size_t pos, size_t count) -> void {
+    for (auto end = pos + count; pos < end;) {
+        auto w = pos / kWordBits;
+        auto bits = std::min(end - pos, kWordBits - pos % kWordBits);
+        auto mask = bits == kWordBits ? kFull : ((uint64_t{1} << bits) - 1) << (pos % kWordBits);
+        bits_[w] &= ~mask;
+        update_summary(w);
+        pos += bits;
+    }
+}
+
+auto AllocatorBitmap::update_summary(size_t w) -> void {
+    auto bit = uint64_t{1} << (w % kWordBits);
+    if (bits_[w] == kFull) {
+        full_[w / kWordBits] |= bit;
+    } else {
+        full_[w / kWordBits] &= ~bit;
+    }
+}
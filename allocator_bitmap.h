@@ -0,0 +1,61 @@
+// allocator_bitmap.h
+// Bitmap allocator definition
+// Author: Hank Bao
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "allocator.h"
+
+// One bit per granule over the heap, set when the granule is allocated.
+// Free space is the runs of clear bits, so freeing coalesces for free.
+// A summary level keeps one bit per word, set when the word is full, to
+// skip 64 full words at a time while searching.
+class AllocatorBitmap : public Allocator {
+   public:
+    AllocatorBitmap(size_t base, size_t size, size_t granule);
+    virtual ~AllocatorBitmap() = default;
+
+    virtual auto malloc(size_t size) -> Chunk override;
+    virtual auto free(Chunk chunk) -> void override;
+    virtual auto relocate(Chunk chunk) -> Chunk override;
+    virtual auto compacted() const -> bool override;
+
+    virtual auto last_searched() const -> size_t override { return searched_; }
+    virtual auto fragmentation() const -> double override;
+    virtual auto chunk_metadata() const -> size_t override;
+    virtual auto print_status() -> void override;
+
+    virtual auto save_state() const -> AllocatorState override;
+    virtual auto restore_state(const AllocatorState& state) -> void override;
+
+   private:
+    // first clear or set bit at or after pos, nbits_ if there's none
+    auto find_clear(size_t pos) const -> size_t;
+    auto find_set(size_t pos) const -> size_t;
+
+    // first word at or after w which isn't full, words_ if there's none
+    auto find_nonfull(size_t w) const -> size_t;
+
+    auto set_range(size_t pos, size_t count) -> void;
+    auto clear_range(size_t pos, size_t count) -> void;
+    auto update_summary(size_t w) -> void;
+
+    auto to_chunk(size_t pos, size_t count) const -> Chunk {
+        return Chunk{base_ + pos * granule_, count * granule_};
+    }
+
+    const size_t base_;
+    const size_t granule_;
+    const size_t nbits_;
+    const size_t words_;
+
+    size_t searched_;
+    std::vector<uint64_t> bits_;
+    std::vector<uint64_t> full_;
+
+    AllocatorBitmap(const AllocatorBitmap&) = delete;
+    AllocatorBitmap& operator=(const AllocatorBitmap&) = delete;
+};
@@ -0,0 +1,91 @@
+// allocator_bypass.cc
+// Large-allocation bypass implementation
+// Author: Hank Bao
+
+#include "allocator_bypass.h"
+
+#include <cstdio>
+
+// Map a new extent for large allocations, small ones go to the heap.
+auto AllocatorBypass::malloc(size_t size) -> Chunk {
+    bypassed_ = size >= threshold_;
+    if (!bypassed_) {
+        auto c = heap_->malloc(size);
+        searched_ = heap_->last_searched();
+        return c;
+    }
+    searched_ = 0;
+
+    // search the gaps between mapped extents for the first fit
+    auto length = (size + page_ - 1) / page_ * page_;
+    auto gap = base_;
+    for (const auto& extent : extents_) {
+        ++searched_;
+
+        if (extent.first - gap >= length) {
+            break;
+        }
+        gap = extent.first + extent.second;
+    }
+
+    if (base_ + size_ - gap >= length) {
+        extents_.emplace(gap, length);
+        return Chunk{gap, size};
+    } else {
+        // region exhausted
+        return Chunk{0, 0};
+    }
+}
+
+// Unmap the extent of a large allocation, small ones go back to the heap.
+auto AllocatorBypass::free(Chunk chunk) -> void {
+    if (contains(chunk)) {
+        extents_.erase(chunk.base());
+    } else {
+        heap_->free(chunk);
+    }
+}
+
+// Extents are unmapped here, the heap releases the rest its own way.
+auto AllocatorBypass::release(const std::vector<Chunk>& live) -> void {
+    std::vector<Chunk> chunks{};
+    for (const auto& chunk : live) {
+        if (contains(chunk)) {
+            extents_.erase(chunk.base());
+        } else {
+            chunks.push_back(chunk);
+        }
+    }
+    heap_->release(chunks);
+}
+
+// Extents are separately mapped, only heap chunks are worth moving.
+auto AllocatorBypass::relocate(Chunk chunk) -> Chunk {
+    return contains(chunk) ? chunk : heap_->relocate(chunk);
+}
+
+auto AllocatorBypass::print_status() -> void {
+    heap_->print_status();
+
+    std::printf("Direct Region [ Extents: %lu ]: ", extents_.size());
+    for (const auto& extent : extents_) {
+        std::printf("[ Base: %lu, Size: %lu ] ", extent.first, extent.second);
+    }
+    std::puts("\n");
+}
+
+auto AllocatorBypass::save_state() const -> AllocatorState {
+    auto state = heap_->save_state();
+    for (const auto& extent : extents_) {
+        state.extents.emplace_back(extent.first, extent.second);
+    }
+    return state;
+}
+
+auto AllocatorBypass::restore_state(const AllocatorState& state) -> void {
+    heap_->restore_state(state);
+    extents_.clear();
+    for (const auto& extent : state.extents) {
+        extents_.emplace(extent.base(), extent.size());
+    }
+}
@@ -0,0 +1,76 @@
+// allocator_bypass.h
+// Large-allocation bypass definition
+// Author: Hank Bao
+
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "allocator.h"
+
+// Serves allocations at or above the threshold from a direct region placed
+// after the heap, similar to the mmap threshold of glibc. Every large
+// allocation gets its own page-granular extent which is returned to the
+// region directly on free, so the heap only ever sees small objects.
+class AllocatorBypass : public Allocator {
+   public:
+    AllocatorBypass(std::unique_ptr<Allocator> heap, size_t base, size_t size, size_t page,
+                    size_t region, size_t threshold)
+        : Allocator{},
+          heap_{std::move(heap)},
+          base_{region_base(base, size, page)},
+          size_{region / page * page},
+          page_{page},
+          threshold_{threshold},
+          searched_{0},
+          bypassed_{false},
+          extents_{} {}
+    virtual ~AllocatorBypass() = default;
+
+    virtual auto malloc(size_t size) -> Chunk override;
+    virtual auto free(Chunk chunk) -> void override;
+    virtual auto relocate(Chunk chunk) -> Chunk override;
+    virtual auto compacted() const -> bool override { return heap_->compacted(); }
+
+    virtual auto mark() -> void override { heap_->mark(); }
+    virtual auto release(const std::vector<Chunk>& live) -> void override;
+
+    virtual auto last_searched() const -> size_t override { return searched_; }
+    virtual auto last_bypassed() const -> bool override { return bypassed_; }
+    virtual auto fragmentation() const -> double override { return heap_->fragmentation(); }
+    virtual auto chunk_metadata() const -> size_t override { return heap_->chunk_metadata(); }
+    virtual auto print_status() -> void override;
+    virtual auto print_search() const -> void override {
+        if (!bypassed_) {
+            heap_->print_search();
+        }
+    }
+
+    virtual auto save_state() const -> AllocatorState override;
+    virtual auto restore_state(const AllocatorState& state) -> void override;
+
+    // the direct region starts at the first page boundary after the heap
+    static auto region_base(size_t base, size_t size, size_t page) -> size_t {
+        return (base + size + page - 1) / page * page;
+    }
+
+   private:
+    auto contains(const Chunk& chunk) const -> bool {
+        return chunk.base() >= base_ && chunk.base() < base_ + size_;
+    }
+
+    std::unique_ptr<Allocator> heap_;
+
+    const size_t base_;
+    const size_t size_;
+    const size_t page_;
+    const size_t threshold_;
+
+    size_t searched_;
+    bool bypassed_;
+    std::map<size_t, size_t> extents_;  // mapped extents, base -> page-rounded size
+
+    AllocatorBypass(const AllocatorBypass&) = delete;
+    AllocatorBypass& operator=(const AllocatorBypass&) = delete;
+};
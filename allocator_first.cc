@@ -4,8 +4,11 @@
 
 #include "allocator_first.h"
 
+#include <cstdint>
+
 // Find the fisrt free chunk to fit the given size.
-auto AllocatorFirst::malloc(size_t size) -> Chunk {
+template <typename Offset>
+auto AllocatorFirst<Offset>::malloc(size_t size) -> Chunk {
     if (0 == size) {
         return Chunk{0, 0};  // {0, 0} as null
     }
@@ -13,13 +16,14 @@ auto AllocatorFirst::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
     searched_ = 0;
+    auto units = to_units(size);
 
     // search for the first fit
     auto fit = freelist_.end();
     for (auto it = freelist_.begin(); it != freelist_.end(); ++it) {
         ++searched_;
 
-        if (it->size() >= size) {
+        if (it->size() >= units) {
             fit = it;
             break;
         }
@@ -27,13 +31,13 @@ auto AllocatorFirst::malloc(size_t size) -> Chunk {
 
     if (fit != freelist_.end()) {
         // perfect fit
-        if (fit->size() == size) {
-            auto c = *fit;
+        if (fit->size() == units) {
+            auto c = to_chunk(*fit);
             freelist_.erase(fit);
             return c;
         } else {
-            Chunk c{fit->base(), size};
-            fit->shrink(size);
+            auto c = to_chunk(fit->base(), units);
+            fit->shrink(units);
             return c;
         }
     } else {
@@ -41,3 +45,6 @@ auto AllocatorFirst::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
 }
+
+template class AllocatorFirst<size_t>;
+template class AllocatorFirst<uint32_t>;
@@ -6,15 +6,21 @@
 
 #include "allocator_base.h"
 
-class AllocatorFirst : public AllocatorBase {
+template <typename Offset>
+class AllocatorFirst : public AllocatorBase<Offset> {
    public:
-    AllocatorFirst(size_t base, size_t size, bool coalesce, ListOrder order)
-        : AllocatorBase{base, size, coalesce, order} {};
+    AllocatorFirst(size_t base, size_t size, size_t granule, bool coalesce, ListOrder order)
+        : AllocatorBase<Offset>{base, size, granule, coalesce, order} {};
     virtual ~AllocatorFirst() = default;
 
     virtual auto malloc(size_t size) -> Chunk override;
 
    private:
+    using AllocatorBase<Offset>::to_chunk;
+    using AllocatorBase<Offset>::to_units;
+    using AllocatorBase<Offset>::searched_;
+    using AllocatorBase<Offset>::freelist_;
+
     AllocatorFirst(const AllocatorFirst&) = delete;
     AllocatorFirst& operator=(const AllocatorFirst&) = delete;
 };
@@ -4,8 +4,13 @@
 
 #include "allocator_next.h"
 
+#include <cstdint>
+#include <cstdio>
+
 // Find the next free chunk to fit the given size according to last search.
-auto AllocatorNext::malloc(size_t size) -> Chunk {
+template <typename Offset>
+auto AllocatorNext<Offset>::malloc(size_t size) -> Chunk {
+    started_ = false;
     if (0 == size) {
         return Chunk{0, 0};  // {0, 0} as null
     }
@@ -13,13 +18,15 @@ auto AllocatorNext::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
     searched_ = 0;
+    auto units = to_units(size);
 
     // move to the next chunk
     if (last_ >= freelist_.size()) {
         last_ = 0;
     }
 
-    std::printf("Next-fit: search from index %lu\n", freelist_.size() > 1 ? last_ + 1 : 0);
+    start_ = freelist_.size() > 1 ? last_ + 1 : 0;
+    started_ = true;
 
     auto it = freelist_.begin();
     for (size_t counter = last_ + 1; counter > 0; --counter) {
@@ -38,7 +45,7 @@ auto AllocatorNext::malloc(size_t size) -> Chunk {
             last_ = 0;
         }
 
-        if (it->size() >= size) {
+        if (it->size() >= units) {
             fit = it;
             break;
         }
@@ -51,13 +58,13 @@ auto AllocatorNext::malloc(size_t size) -> Chunk {
 
     if (fit != freelist_.end()) {
         // perfect fit
-        if (fit->size() == size) {
-            auto c = *fit;
+        if (fit->size() == units) {
+            auto c = to_chunk(*fit);
             freelist_.erase(fit);
             return c;
         } else {
-            Chunk c{fit->base(), size};
-            fit->shrink(size);
+            auto c = to_chunk(fit->base(), units);
+            fit->shrink(units);
             return c;
         }
     } else {
@@ -65,3 +72,27 @@ auto AllocatorNext::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
 }
+
+// Printed by the caller, so it stays out of the timed malloc.
+template <typename Offset>
+auto AllocatorNext<Offset>::print_search() const -> void {
+    if (started_) {
+        std::printf("Next-fit: search from index %lu\n", start_);
+    }
+}
+
+template <typename Offset>
+auto AllocatorNext<Offset>::save_state() const -> AllocatorState {
+    auto state = AllocatorBase<Offset>::save_state();
+    state.cursor = last_;
+    return state;
+}
+
+template <typename Offset>
+auto AllocatorNext<Offset>::restore_state(const AllocatorState& state) -> void {
+    AllocatorBase<Offset>::restore_state(state);
+    last_ = state.cursor;
+}
+
+template class AllocatorNext<size_t>;
+template class AllocatorNext<uint32_t>;
@@ -6,16 +6,28 @@
 
 #include "allocator_base.h"
 
-class AllocatorNext : public AllocatorBase {
+template <typename Offset>
+class AllocatorNext : public AllocatorBase<Offset> {
    public:
-    AllocatorNext(size_t base, size_t size, bool coalesce, ListOrder order)
-        : AllocatorBase{base, size, coalesce, order}, last_{0} {};
+    AllocatorNext(size_t base, size_t size, size_t granule, bool coalesce, ListOrder order)
+        : AllocatorBase<Offset>{base, size, granule, coalesce, order}, last_{0}, start_{0}, started_{false} {};
     virtual ~AllocatorNext() = default;
 
     virtual auto malloc(size_t size) -> Chunk override;
+    virtual auto print_search() const -> void override;
+
+    virtual auto save_state() const -> AllocatorState override;
+    virtual auto restore_state(const AllocatorState& state) -> void override;
 
    private:
+    using AllocatorBase<Offset>::to_chunk;
+    using AllocatorBase<Offset>::to_units;
+    using AllocatorBase<Offset>::searched_;
+    using AllocatorBase<Offset>::freelist_;
+
     size_t last_;
+    size_t start_;  // index the last search started from
+    bool started_;
 
     AllocatorNext(const AllocatorNext&) = delete;
     AllocatorNext& operator=(const AllocatorNext&) = delete;
@@ -0,0 +1,113 @@
+// allocator_region.cc
+// Region allocator implementation
+// Author: Hank Bao
+
+#include "allocator_region.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// Bump the top of the heap by the given size.
+auto AllocatorRegion::malloc(size_t size) -> Chunk {
+    if (0 == size) {
+        return Chunk{0, 0};  // {0, 0} as null
+    }
+    searched_ = 1;
+
+    auto length = (size + granule_ - 1) / granule_ * granule_;
+    if (end_ - top_ < length) {
+        // region exhausted
+        return Chunk{0, 0};
+    }
+
+    Chunk c{top_, length};
+    top_ += length;
+    return c;
+}
+
+// Currently we don't consider invalid chuck
+auto AllocatorRegion::free(Chunk chunk) -> void {
+    if (!track_) {
+        return;
+    }
+
+    freed_.emplace(chunk.base() + chunk.size(), chunk.base());
+    rollback();
+}
+
+// Everything above the mark goes at once, the live chunks aren't needed.
+auto AllocatorRegion::release(const std::vector<Chunk>&) -> void {
+    if (marks_.empty()) {
+        return;
+    }
+
+    top_ = marks_.back();
+    marks_.pop_back();
+
+    if (!freed_.empty()) {
+        freed_.erase(freed_.upper_bound(top_), freed_.end());
+        rollback();
+    }
+}
+
+auto AllocatorRegion::rollback() -> void {
+    for (auto it = freed_.find(top_); it != freed_.end(); it = freed_.find(top_)) {
+        top_ = it->second;
+        freed_.erase(it);
+    }
+
+    // a mark above the new top would leak the gap on release
+    for (auto& m : marks_) {
+        m = std::min(m, top_);
+    }
+}
+
+// External fragmentation: the share of free space outside the largest free chunk
+auto AllocatorRegion::fragmentation() const -> double {
+    size_t total = end_ - top_;
+    size_t largest = end_ - top_;
+    for (const auto& chunk : freed_) {
+        total += chunk.first - chunk.second;
+        largest = std::max(largest, chunk.first - chunk.second);
+    }
+
+    return total == 0 ? 0.0 : 1.0 - static_cast<double>(largest) / total;
+}
+
+// Only tracked frees take metadata, a map node with its three links and color.
+auto AllocatorRegion::chunk_metadata() const -> size_t {
+    return track_ ? sizeof(std::map<size_t, size_t>::value_type) + 4 * sizeof(void*) : 0;
+}
+
+auto AllocatorRegion::print_status() -> void {
+    std::printf("Region [ Top: %lu, Marks: %lu ]: ", top_, marks_.size());
+    for (auto& chunk : save_state().freelist) {
+        std::printf("[ Base: %lu, Size: %lu ] ", chunk.base(), chunk.size());
+    }
+    std::puts("\n");
+}
+
+// The free space above the top comes first, then the tracked frees.
+auto AllocatorRegion::save_state() const -> AllocatorState {
+    auto state = AllocatorState{{}, 0, {}, marks_};
+    if (top_ < end_) {
+        state.freelist.emplace_back(top_, end_ - top_);
+    }
+    for (const auto& chunk : freed_) {
+        state.freelist.emplace_back(chunk.second, chunk.first - chunk.second);
+    }
+    return state;
+}
+
+auto AllocatorRegion::restore_state(const AllocatorState& state) -> void {
+    top_ = end_;
+    freed_.clear();
+    for (const auto& chunk : state.freelist) {
+        if (chunk.base() + chunk.size() == end_) {
+            top_ = chunk.base();
+        } else {
+            freed_.emplace(chunk.base() + chunk.size(), chunk.base());
+        }
+    }
+    marks_ = state.marks;
+}
@@ -0,0 +1,60 @@
+// allocator_region.h
+// Region allocator definition
+// Author: Hank Bao
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "allocator.h"
+
+// Bump-allocates from the top of the heap. Regions nest with marks, and
+// releasing a mark resets the top to it at once. Frees are no-ops unless
+// tracked, then the top rolls back over freed chunks once everything above
+// them is freed too.
+class AllocatorRegion : public Allocator {
+   public:
+    AllocatorRegion(size_t base, size_t size, size_t granule, bool track)
+        : Allocator{},
+          end_{base + size / granule * granule},
+          granule_{granule},
+          track_{track},
+          searched_{0},
+          top_{base},
+          marks_{},
+          freed_{} {}
+    virtual ~AllocatorRegion() = default;
+
+    virtual auto malloc(size_t size) -> Chunk override;
+    virtual auto free(Chunk chunk) -> void override;
+    virtual auto relocate(Chunk chunk) -> Chunk override { return chunk; }
+    virtual auto compacted() const -> bool override { return true; }
+
+    virtual auto mark() -> void override { marks_.push_back(top_); }
+    virtual auto release(const std::vector<Chunk>& live) -> void override;
+
+    virtual auto last_searched() const -> size_t override { return searched_; }
+    virtual auto fragmentation() const -> double override;
+    virtual auto chunk_metadata() const -> size_t override;
+    virtual auto print_status() -> void override;
+
+    virtual auto save_state() const -> AllocatorState override;
+    virtual auto restore_state(const AllocatorState& state) -> void override;
+
+   private:
+    // roll the top back over the tracked frees right below it
+    auto rollback() -> void;
+
+    const size_t end_;
+    const size_t granule_;
+    const bool track_;
+
+    size_t searched_;
+    size_t top_;
+    std::vector<size_t> marks_;     // tops saved by mark()
+    std::map<size_t, size_t> freed_;  // tracked frees below the top, end -> base
+
+    AllocatorRegion(const AllocatorRegion&) = delete;
+    AllocatorRegion& operator=(const AllocatorRegion&) = delete;
+};
@@ -4,8 +4,11 @@
 
 #include "allocator_worst.h"
 
+#include <cstdint>
+
 // Find the biggest free chunk to fit the given size.
-auto AllocatorWorst::malloc(size_t size) -> Chunk {
+template <typename Offset>
+auto AllocatorWorst<Offset>::malloc(size_t size) -> Chunk {
     if (0 == size) {
         return Chunk{0, 0};  // {0, 0} as null
     }
@@ -13,13 +16,14 @@ auto AllocatorWorst::malloc(size_t size) -> Chunk {
         return Chunk{0, 0};
     }
     searched_ = 0;
+    auto units = to_units(size);
 
     // search for the biggest fit
     auto fit = freelist_.end();
     for (auto it = freelist_.begin(); it != freelist_.end(); ++it) {
         ++searched_;
 
-        if (it->size() >= size) {
+        if (it->size() >= units) {
             if (fit == freelist_.end()) {
                 fit = it;
             } else if (it->size() > fit->size()) {
@@ -29,16 +33,19 @@ auto AllocatorWorst::malloc(size_t size) -> Chunk {
     }
 
     if (fit != freelist_.end()) {
-        if (fit->size() == size) {  // perfect fit
-            auto c = *fit;
+        if (fit->size() == units) {  // perfect fit
+            auto c = to_chunk(*fit);
             freelist_.erase(fit);
             return c;
         } else {  // biggest fit
-            Chunk c{fit->base(), size};
-            fit->shrink(size);
+            auto c = to_chunk(fit->base(), units);
+            fit->shrink(units);
             return c;
         }
     } else {
         return Chunk{0, 0};  // search failed
     }
 }
+
+template class AllocatorWorst<size_t>;
+template class AllocatorWorst<uint32_t>;
@@ -6,31 +6,37 @@
 
 #include <cstddef>
 
-class Chunk {
+// Offset is the width of base and size. Free lists of small heaps use a
+// narrow one to store offsets from the heap base instead of addresses.
+template <typename Offset>
+class BasicChunk {
    public:
-    Chunk(size_t base, size_t size) : base_{base}, size_{size} {}
-    ~Chunk() {}
+    BasicChunk(Offset base, Offset size) : base_{base}, size_{size} {}
+    ~BasicChunk() {}
 
-    auto base() const -> size_t { return base_; }
-    auto size() const -> size_t { return size_; }
+    auto base() const -> Offset { return base_; }
+    auto size() const -> Offset { return size_; }
     auto is_null() const -> bool { return base_ == 0 && size_ == 0; }
 
     // shrink from the head of chunk
-    auto shrink(size_t size) -> void {
+    auto shrink(Offset size) -> void {
         base_ += size;
         size_ -= size;
     }
 
     // expand from the tail of chunk
-    auto expand(size_t size) -> void {
+    auto expand(Offset size) -> void {
         size_ += size;
     }
 
    private:
-    size_t base_;
-    size_t size_;
+    Offset base_;
+    Offset size_;
 };
 
-inline auto operator==(const Chunk& a, const Chunk& b) -> bool {
+template <typename Offset>
+inline auto operator==(const BasicChunk<Offset>& a, const BasicChunk<Offset>& b) -> bool {
     return a.base() == b.base() && a.size() == b.size();
 }
+
+using Chunk = BasicChunk<size_t>;
@@ -0,0 +1,75 @@
+// compactor.cc
+// Incremental heap compactor implementation
+// Author: Hank Bao
+
+#include "compactor.h"
+
+#include <iterator>
+#include <limits>
+
+namespace {
+
+// handles examined by a step at most
+const size_t kStepHandles = 16;
+
+}  // namespace
+
+auto Compactor::step(std::vector<Chunk>& handles) -> size_t {
+    last_moves_.clear();
+    return compact(handles, budget_, kStepHandles);
+}
+
+auto Compactor::run(std::vector<Chunk>& handles) -> size_t {
+    const auto unbounded = std::numeric_limits<size_t>::max();
+
+    // full passes from the base until nothing moves
+    size_t total = 0;
+    cursor_ = 0;
+    last_moves_.clear();
+    for (;;) {
+        auto moved = compact(handles, unbounded, unbounded);
+        if (moved == 0) {
+            return total;
+        }
+        total += moved;
+    }
+}
+
+auto Compactor::compact(std::vector<Chunk>& handles, size_t budget, size_t limit) -> size_t {
+    if (allocator_.compacted()) {
+        cursor_ = 0;
+        return 0;
+    }
+
+    // going up from the cursor, every move opens the hole for the next chunk,
+    // once past the last handle start over from the base
+    auto it = live_.lower_bound(cursor_);
+    if (it == live_.end()) {
+        it = live_.begin();
+    }
+
+    size_t moved = 0;
+    for (size_t examined = 0; it != live_.end() && examined < limit && moved < budget; ++examined) {
+        auto idx = it->second;
+        auto chunk = handles[idx];
+        auto relocated = allocator_.relocate(chunk);
+
+        auto next = std::next(it);
+        if (!(relocated == chunk)) {
+            last_moves_.push_back(Move{idx, chunk.base(), relocated.base()});
+            handles[idx] = relocated;
+            live_.erase(it);
+            live_.emplace(relocated.base(), idx);
+            moved += relocated.size();
+            ++relocations_;
+        }
+        it = next;
+    }
+    cursor_ = it == live_.end() ? 0 : it->first;
+
+    if (moved > 0) {
+        ++steps_;
+        moved_ += moved;
+    }
+    return moved;
+}
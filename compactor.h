@@ -0,0 +1,73 @@
+// compactor.h
+// Incremental heap compactor definition
+// Author: Hank Bao
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "allocator.h"
+#include "chunk.h"
+
+// Slides live chunks toward the heap base so the free space gathers into
+// one contiguous chunk at the top. Callers hold indices into the handle
+// table instead of chunks, the compactor updates the table as chunks move.
+// Live handles are indexed by address, so each step picks up where the
+// last one stopped and examines a bounded number of them.
+class Compactor {
+   public:
+    // A chunk slid down by the last step or run.
+    struct Move {
+        size_t handle;
+        size_t from;
+        size_t to;
+    };
+
+    Compactor(Allocator& allocator, size_t budget)
+        : allocator_{allocator},
+          budget_{budget},
+          cursor_{0},
+          live_{},
+          last_moves_{},
+          steps_{0},
+          relocations_{0},
+          moved_{0} {}
+    ~Compactor() = default;
+
+    // Keep the index in sync as handles are allocated and freed.
+    auto track(size_t handle, const Chunk& chunk) -> void { live_.emplace(chunk.base(), handle); }
+    auto untrack(const Chunk& chunk) -> void { live_.erase(chunk.base()); }
+
+    // Move chunks in address order from the cursor until the budget is spent
+    // or enough handles are examined, returns the bytes moved. A chunk is
+    // moved as a whole even if it exceeds the budget.
+    auto step(std::vector<Chunk>& handles) -> size_t;
+
+    // Keep moving until the heap is fully compacted, returns the bytes moved.
+    auto run(std::vector<Chunk>& handles) -> size_t;
+
+    // Moves made by the last call to step or run, left for the caller to report.
+    auto last_moves() const -> const std::vector<Move>& { return last_moves_; }
+
+    auto steps() const -> size_t { return steps_; }
+    auto relocations() const -> size_t { return relocations_; }
+    auto moved() const -> size_t { return moved_; }
+
+   private:
+    auto compact(std::vector<Chunk>& handles, size_t budget, size_t limit) -> size_t;
+
+    Allocator& allocator_;
+    const size_t budget_;
+
+    size_t cursor_;                  // address the last step stopped at
+    std::map<size_t, size_t> live_;  // live chunks, base -> handle
+    std::vector<Move> last_moves_;
+
+    size_t steps_;
+    size_t relocations_;
+    size_t moved_;
+
+    Compactor(const Compactor&) = delete;
+    Compactor& operator=(const Compactor&) = delete;
+};
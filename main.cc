@@ -2,7 +2,11 @@
 // Simple malloc/free implementation for CS5600
 // Author: Hank Bao
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
+#include <limits>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -14,21 +18,21 @@
 
 #include "allocator.h"
 #include "allocator_best.h"
+#include "allocator_bitmap.h"
+#include "allocator_bypass.h"
 #include "allocator_worst.h"
 #include "allocator_first.h"
 #include "allocator_next.h"
+#include "allocator_region.h"
 #include "chunk.h"
-
-enum class Policy {
-    BestFit,
-    WorstFit,
-    FirstFit,
-    NextFit,
-};
+#include "compactor.h"
+#include "snapshot.h"
 
 enum class Op {
     Alloc,
     Free,
+    Mark,
+    Release,
 };
 
 class MemOp {
@@ -38,7 +42,8 @@ class MemOp {
 
     auto op() const -> Op { return op_; }
 
-    // num is size when allocating, and index of allocated chunk when freeing
+    // num is size when allocating, and index of allocated chunk when freeing,
+    // marks and releases don't take a num
     auto num() const -> size_t { return num_; }
 
    private:
@@ -51,11 +56,21 @@ class MemOp {
     std::puts("Supported options:");
     std::puts("-s, --size=HEAPSIZE\n\tsize of the heap");
     std::puts("-b, --base=BASEADDR\n\tbase address of heap");
-    std::puts("-p, --policy=POLICY\n\tlist search (BEST, WORST, FIRST, NEXT)");
+    std::puts("-p, --policy=POLICY\n\tlist search (BEST, WORST, FIRST, NEXT, BITMAP, REGION)");
     std::puts(
         "-o, --order=ORDER\n\tlist order (ADDRSORT, SIZESORT+, SIZESORT-, INSERT-FRONT, INSERT-BACK)");
     std::puts("-c, --coalesce\n\tcoalesce the free list");
-    std::puts("-a, --memops=OPSLIST\n\tlist of ops (+10,-0,etc)");
+    std::puts("-T, --track-frees\n\ttrack frees of the region policy to roll its top back");
+    std::puts("-g, --granule=SIZE\n\tround allocations up to multiples of SIZE");
+    std::puts("-n, --narrow\n\tstore free chunks as 32-bit granule offsets from the heap base");
+    std::puts("-a, --memops=OPSLIST\n\tlist of ops (+10,-0,@,!,etc), @ opens a region and ! releases it");
+    std::puts("-t, --threshold=SIZE\n\tserve allocations of SIZE or more from the direct region");
+    std::puts("-r, --region=SIZE\n\tsize of the direct region (1 MiB by default)");
+    std::puts("-P, --page=PAGESIZE\n\tpage size of the direct region (4096 by default)");
+    std::puts("-k, --compact=BUDGET\n\tcompact the heap moving up to BUDGET bytes after each op");
+    std::puts("-q, --quiet\n\tonly print the summary after executing the mem-ops");
+    std::puts("-l, --load=FILE\n\tresume from a snapshot, policy and heap settings come from the snapshot");
+    std::puts("-w, --save=FILE\n\tsave a snapshot after executing the mem-ops");
     std::puts("-h, --help\n\tprint usage message and exit");
 
     ::exit(onerror ? EXIT_FAILURE : EXIT_SUCCESS);
@@ -86,6 +101,10 @@ auto policy_to_str(Policy policy) -> std::string {
             return "FIRST";
         case Policy::NextFit:
             return "NEXT";
+        case Policy::Bitmap:
+            return "BITMAP";
+        case Policy::Region:
+            return "REGION";
     }
 }
 
@@ -110,16 +129,36 @@ auto op_to_str(Op op) -> std::string {
             return "+";
         case Op::Free:
             return "-";
+        case Op::Mark:
+            return "@";
+        case Op::Release:
+            return "!";
+    }
+}
+
+auto memop_to_str(const MemOp& op) -> std::string {
+    switch (op.op()) {
+        case Op::Alloc:
+        case Op::Free:
+            return op_to_str(op.op()) + std::to_string(op.num());
+        case Op::Mark:
+        case Op::Release:
+            return op_to_str(op.op());
     }
+    return "";
 }
 
 auto ops_to_str(const std::vector<MemOp>& ops) -> std::string {
     std::stringstream ss;
+    if (ops.empty()) {
+        return ss.str();
+    }
+
     auto it = ops.cbegin();
-    ss << op_to_str(it->op()) << it->num();
+    ss << memop_to_str(*it);
     ++it;
     for (; it != ops.cend(); ++it) {
-        ss << "," << op_to_str(it->op()) << it->num();
+        ss << "," << memop_to_str(*it);
     }
     return ss.str();
 }
@@ -144,6 +183,56 @@ auto parse_base_addr(const std::string& str) -> size_t {
     return base_addr;
 }
 
+auto parse_granule(const std::string& str) -> size_t {
+    size_t granule = std::stoi(str);
+    if (granule <= 0) {
+        std::fprintf(stderr, "Invalid granule: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return granule;
+}
+
+auto parse_threshold(const std::string& str) -> size_t {
+    auto threshold = std::stoi(str);
+    if (threshold < 0) {
+        std::fprintf(stderr, "Invalid threshold: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return threshold;
+}
+
+auto parse_region_size(const std::string& str) -> size_t {
+    auto region_size = std::stoi(str);
+    if (region_size < 1) {
+        std::fprintf(stderr, "Invalid region size: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return region_size;
+}
+
+auto parse_page_size(const std::string& str) -> size_t {
+    auto page_size = std::stoi(str);
+    if (page_size < 1) {
+        std::fprintf(stderr, "Invalid page size: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return page_size;
+}
+
+auto parse_compact_budget(const std::string& str) -> size_t {
+    size_t budget = std::stoi(str);
+    if (budget <= 0) {
+        std::fprintf(stderr, "Invalid compaction budget: %s\n", str.c_str());
+        print_usage(true);
+    }
+
+    return budget;
+}
+
 auto parse_policy(const std::string& policy) -> Policy {
     if (policy == "BEST") {
         return Policy::BestFit;
@@ -153,6 +242,10 @@ auto parse_policy(const std::string& policy) -> Policy {
         return Policy::FirstFit;
     } else if (policy == "NEXT") {
         return Policy::NextFit;
+    } else if (policy == "BITMAP") {
+        return Policy::Bitmap;
+    } else if (policy == "REGION") {
+        return Policy::Region;
     } else {
         std::fprintf(stderr, "Invalid policy: %s\n", policy.c_str());
         print_usage(true);
@@ -195,6 +288,12 @@ auto parse_ops(const std::string& ops) -> std::vector<MemOp> {
                 size_t num = std::stoi(op.substr(1));
                 oplist.push_back(MemOp(Op::Free, num));
             } break;
+            case '@':
+                oplist.push_back(MemOp(Op::Mark, 0));
+                break;
+            case '!':
+                oplist.push_back(MemOp(Op::Release, 0));
+                break;
             default:
                 std::fprintf(stderr, "Invalid mem-op: %s\n", op.c_str());
                 print_usage(true);
@@ -204,19 +303,53 @@ auto parse_ops(const std::string& ops) -> std::vector<MemOp> {
     return oplist;
 }
 
-auto exec_memops(const std::vector<MemOp>& ops, std::unique_ptr<Allocator> allocator) -> void {
-    if (ops.empty()) {
-        std::fprintf(stderr, "Invalid mem-ops: no op found.\n");
-        print_usage(true);
-    }
-
-    std::vector<Chunk> allocated{};
-    std::set<size_t> freed{};
+// allocated, freed and marks carry the allocations and open regions over
+// from a loaded snapshot. With a compactor, allocated is the handle table
+// and chunks may move. Only the time spent in the allocator counts towards
+// throughput.
+auto exec_memops(const std::vector<MemOp>& ops, Allocator& allocator, std::vector<Chunk>& allocated,
+                 std::set<size_t>& freed, std::vector<size_t>& marks, Compactor* compactor, bool quiet)
+    -> void {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = Clock::duration::zero();
+
+    size_t avoided = 0;
+    // heap searches are kept apart from the direct region's
+    size_t allocs = 0;
+    size_t total_searched = 0;
+    size_t max_searched = 0;
+    size_t direct_allocs = 0;
+    size_t direct_searched = 0;
+
+    auto print_moves = [&]() {
+        if (!quiet) {
+            for (const auto& m : compactor->last_moves()) {
+                std::printf("Compact: ptr[%lu] moved from %lu to %lu\n", m.handle, m.from, m.to);
+            }
+        }
+    };
 
     for (const auto& op : ops) {
         switch (op.op()) {
             case Op::Alloc: {
-                auto c = allocator->malloc(op.num());
+                auto start = Clock::now();
+                auto c = allocator.malloc(op.num());
+                elapsed += Clock::now() - start;
+
+                // compact the whole heap and try again before giving up
+                if (c.is_null() && compactor != nullptr && compactor->run(allocated) > 0) {
+                    print_moves();
+                    start = Clock::now();
+                    c = allocator.malloc(op.num());
+                    elapsed += Clock::now() - start;
+                    if (!c.is_null()) {
+                        ++avoided;
+                    }
+                }
+
+                if (!quiet) {
+                    allocator.print_search();
+                }
 
                 // allocation failed if null chunk returned
                 if (c.is_null()) {
@@ -224,11 +357,25 @@ auto exec_memops(const std::vector<MemOp>& ops, std::unique_ptr<Allocator> alloc
                     ::exit(EXIT_FAILURE);
                 }
 
-                auto searched = allocator->last_searched();
-                std::printf("ptr[%lu] = Alloc(%lu) returned %lu (searched %lu %s)\n",
-                            allocated.size(), c.size(), c.base(), searched,
-                            searched > 1 ? "elements" : "element");
+                auto searched = allocator.last_searched();
+                if (!quiet) {
+                    std::printf("ptr[%lu] = Alloc(%lu) returned %lu (searched %lu %s)\n",
+                                allocated.size(), c.size(), c.base(), searched,
+                                searched > 1 ? "elements" : "element");
+                }
+                if (compactor != nullptr) {
+                    compactor->track(allocated.size(), c);
+                }
                 allocated.push_back(c);
+
+                if (allocator.last_bypassed()) {
+                    ++direct_allocs;
+                    direct_searched += searched;
+                } else {
+                    ++allocs;
+                    total_searched += searched;
+                    max_searched = std::max(max_searched, searched);
+                }
             } break;
 
             case Op::Free: {
@@ -246,16 +393,104 @@ auto exec_memops(const std::vector<MemOp>& ops, std::unique_ptr<Allocator> alloc
                 }
 
                 auto c = allocated.at(idx);
-                std::printf("Free(ptr[%lu]) at %lu\n", idx, c.base());
-                allocator->free(c);
+                if (!quiet) {
+                    std::printf("Free(ptr[%lu]) at %lu\n", idx, c.base());
+                }
+                auto start = Clock::now();
+                allocator.free(c);
+                elapsed += Clock::now() - start;
 
                 // mark the index as freed
                 freed.insert(idx);
+                if (compactor != nullptr) {
+                    compactor->untrack(c);
+                }
+            } break;
+
+            case Op::Mark: {
+                // a region starts at the next allocation
+                marks.push_back(allocated.size());
+                if (!quiet) {
+                    std::printf("Mark(%lu) at ptr[%lu]\n", marks.size(), allocated.size());
+                }
+                auto start = Clock::now();
+                allocator.mark();
+                elapsed += Clock::now() - start;
+            } break;
+
+            case Op::Release: {
+                if (marks.empty()) {
+                    std::fprintf(stderr, "Release without mark\n");
+                    ::exit(EXIT_FAILURE);
+                }
+
+                // everything allocated since the mark and not freed yet
+                std::vector<Chunk> live{};
+                for (auto idx = marks.back(); idx < allocated.size(); ++idx) {
+                    if (freed.insert(idx).second) {
+                        live.push_back(allocated[idx]);
+                        if (compactor != nullptr) {
+                            compactor->untrack(allocated[idx]);
+                        }
+                    }
+                }
+
+                if (!quiet) {
+                    std::printf("Release(%lu) from ptr[%lu] (%lu live)\n", marks.size(), marks.back(),
+                                live.size());
+                }
+                marks.pop_back();
+                auto start = Clock::now();
+                allocator.release(live);
+                elapsed += Clock::now() - start;
             } break;
         }
 
-        allocator->print_status();
+        if (compactor != nullptr) {
+            compactor->step(allocated);
+            print_moves();
+        }
+
+        if (!quiet) {
+            allocator.print_status();
+        }
+    }
+
+    auto ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    std::printf("Throughput: %lu ops in %.3f ms (%.0f ops/s)\n\n", ops.size(), ms,
+                ms > 0 ? ops.size() / ms * 1000 : 0.0);
+    std::printf("Summary: %lu heap allocs, searched %lu elements (avg %.2f, max %lu), heap fragmentation %.2f%%\n\n",
+                allocs, total_searched, allocs > 0 ? static_cast<double>(total_searched) / allocs : 0.0,
+                max_searched, allocator.fragmentation() * 100);
+    if (direct_allocs > 0) {
+        std::printf("Direct: %lu allocs, searched %lu extents (avg %.2f)\n\n", direct_allocs,
+                    direct_searched, static_cast<double>(direct_searched) / direct_allocs);
+    }
+    std::printf("Metadata: %lu bytes per free chunk\n\n", allocator.chunk_metadata());
+    if (compactor != nullptr) {
+        std::printf("Compaction: %lu steps moved %lu bytes in %lu relocations, avoided %lu failed allocs\n\n",
+                    compactor->steps(), compactor->moved(), compactor->relocations(), avoided);
+    }
+}
+
+template <typename Offset>
+auto make_allocator(Policy policy, size_t base_addr, size_t heap_size, size_t granule, bool coalesce,
+                    ListOrder order, bool track) -> std::unique_ptr<Allocator> {
+    switch (policy) {
+        case Policy::BestFit:
+            return std::make_unique<AllocatorBest<Offset>>(base_addr, heap_size, granule, coalesce, order);
+        case Policy::WorstFit:
+            return std::make_unique<AllocatorWorst<Offset>>(base_addr, heap_size, granule, coalesce, order);
+        case Policy::FirstFit:
+            return std::make_unique<AllocatorFirst<Offset>>(base_addr, heap_size, granule, coalesce, order);
+        case Policy::NextFit:
+            return std::make_unique<AllocatorNext<Offset>>(base_addr, heap_size, granule, coalesce, order);
+        case Policy::Bitmap:
+            return std::make_unique<AllocatorBitmap>(base_addr, heap_size, granule);
+        case Policy::Region:
+            return std::make_unique<AllocatorRegion>(base_addr, heap_size, granule, track);
     }
+    return nullptr;
 }
 
 auto main(int argc, char** argv) -> int {
@@ -263,9 +498,20 @@ auto main(int argc, char** argv) -> int {
     size_t heap_size = 100;
     size_t base_addr = 1000;
     Policy policy = Policy::BestFit;
+    bool policy_set = false;
     ListOrder order = ListOrder::AddrSort;
     bool coalesce = false;
+    bool track = false;
+    size_t granule = 1;
+    bool narrow = false;
+    bool quiet = false;
     std::vector<MemOp> ops{};
+    std::string load_path{};
+    std::string save_path{};
+    size_t threshold = 0;
+    size_t region_size = 1 << 20;
+    size_t page_size = 4096;
+    size_t compact_budget = 0;
 
     struct option long_options[] = {
         {"size", required_argument, nullptr, 's'},
@@ -273,11 +519,21 @@ auto main(int argc, char** argv) -> int {
         {"policy", required_argument, nullptr, 'p'},
         {"order", required_argument, nullptr, 'o'},
         {"coalesce", no_argument, 0, 'c'},
+        {"track-frees", no_argument, nullptr, 'T'},
+        {"granule", required_argument, nullptr, 'g'},
+        {"narrow", no_argument, nullptr, 'n'},
         {"memops", required_argument, nullptr, 'a'},
+        {"compact", required_argument, nullptr, 'k'},
+        {"quiet", no_argument, nullptr, 'q'},
+        {"load", required_argument, nullptr, 'l'},
+        {"save", required_argument, nullptr, 'w'},
+        {"threshold", required_argument, nullptr, 't'},
+        {"region", required_argument, nullptr, 'r'},
+        {"page", required_argument, nullptr, 'P'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0}};
 
-    while ((opt = getopt_long(argc, argv, "s:b:p:o:ca:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "s:b:p:o:cTg:na:k:ql:w:t:r:P:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'h':
                 print_usage(false);
@@ -290,6 +546,7 @@ auto main(int argc, char** argv) -> int {
                 break;
             case 'p':
                 policy = parse_policy(optarg);
+                policy_set = true;
                 break;
             case 'o':
                 order = parse_order(optarg);
@@ -297,41 +554,156 @@ auto main(int argc, char** argv) -> int {
             case 'c':
                 coalesce = true;
                 break;
+            case 'T':
+                track = true;
+                break;
+            case 'g':
+                granule = parse_granule(optarg);
+                break;
+            case 'n':
+                narrow = true;
+                break;
             case 'a':
                 ops = parse_ops(optarg);
                 break;
+            case 'k':
+                compact_budget = parse_compact_budget(optarg);
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'l':
+                load_path = optarg;
+                break;
+            case 'w':
+                save_path = optarg;
+                break;
+            case 't':
+                threshold = parse_threshold(optarg);
+                break;
+            case 'r':
+                region_size = parse_region_size(optarg);
+                break;
+            case 'P':
+                page_size = parse_page_size(optarg);
+                break;
             default:
                 std::fprintf(stderr, "Unknown option: %c\n", optopt);
                 print_usage(true);
         }
     }
 
+    Snapshot snapshot{base_addr, heap_size, policy, coalesce, track, order, granule, threshold, page_size,
+                      region_size, AllocatorState{}, {}, {}, {}};
+    if (!load_path.empty()) {
+        if (!load_snapshot(load_path, snapshot)) {
+            ::exit(EXIT_FAILURE);
+        }
+
+        // the allocator state only makes sense to the policy that saved it
+        if (policy_set && policy != snapshot.policy) {
+            std::fprintf(stderr, "Snapshot was saved with policy %s, not %s\n",
+                         policy_to_str(snapshot.policy).c_str(), policy_to_str(policy).c_str());
+            ::exit(EXIT_FAILURE);
+        }
+        policy = snapshot.policy;
+        base_addr = snapshot.base;
+        heap_size = snapshot.size;
+        coalesce = snapshot.coalesce;
+        track = snapshot.track;
+        order = snapshot.order;
+        granule = snapshot.granule;
+        threshold = snapshot.threshold;
+        page_size = snapshot.page;
+        region_size = snapshot.region;
+    } else if (ops.empty()) {
+        std::fprintf(stderr, "Invalid mem-ops: no op found.\n");
+        print_usage(true);
+    }
+
+    if (heap_size % granule != 0) {
+        std::fprintf(stderr, "Heap size %lu is not a multiple of granule %lu\n", heap_size, granule);
+        print_usage(true);
+    }
+    if (narrow && (policy == Policy::Bitmap || policy == Policy::Region)) {
+        std::fprintf(stderr, "Policy %s has no free list to narrow\n", policy_to_str(policy).c_str());
+        print_usage(true);
+    }
+    if (threshold > 0 && region_size < page_size) {
+        std::fprintf(stderr, "Region size %lu is smaller than page size %lu\n", region_size, page_size);
+        print_usage(true);
+    }
+    if (track && policy != Policy::Region) {
+        std::fprintf(stderr, "Policy %s has no frees to track\n", policy_to_str(policy).c_str());
+        print_usage(true);
+    }
+    if (narrow && heap_size / granule > std::numeric_limits<uint32_t>::max()) {
+        std::fprintf(stderr, "Heap of %lu granules is too large for 32-bit offsets\n", heap_size / granule);
+        print_usage(true);
+    }
+
     std::printf("base_addr: %lu\n", base_addr);
     std::printf("heap_size: %lu\n", heap_size);
     std::printf("policy: %s\n", policy_to_str(policy).c_str());
-    std::printf("order: %s\n", order_to_str(order).c_str());
-    std::printf("coalesce: %s\n", coalesce ? "true" : "false");
+    // only the fit policies keep a free list
+    if (policy == Policy::Region) {
+        std::printf("track_frees: %s\n", track ? "true" : "false");
+    } else if (policy != Policy::Bitmap) {
+        std::printf("order: %s\n", order_to_str(order).c_str());
+        std::printf("coalesce: %s\n", coalesce ? "true" : "false");
+    }
+    std::printf("granule: %lu\n", granule);
+    if (policy != Policy::Bitmap && policy != Policy::Region) {
+        std::printf("offsets: %s\n", narrow ? "32-bit" : "native");
+    }
+    if (threshold > 0) {
+        std::printf("threshold: %lu\n", threshold);
+        std::printf("region_base: %lu\n", AllocatorBypass::region_base(base_addr, heap_size, page_size));
+        std::printf("region_size: %lu\n", region_size / page_size * page_size);
+        std::printf("page_size: %lu\n", page_size);
+    }
+    if (compact_budget > 0) {
+        std::printf("compact_budget: %lu\n", compact_budget);
+    }
     std::printf("mem-ops: %s\n", ops_to_str(ops).c_str());
+    if (!load_path.empty()) {
+        std::printf("snapshot: %s (%lu allocated, %lu freed)\n", load_path.c_str(),
+                    snapshot.allocated.size(), snapshot.freed.size());
+    }
     std::puts("");
 
-    std::unique_ptr<Allocator> allocator = nullptr;
-    switch (policy) {
-        case Policy::BestFit:
-            allocator = std::make_unique<AllocatorBest>(base_addr, heap_size, coalesce, order);
-            break;
+    auto allocator = narrow ? make_allocator<uint32_t>(policy, base_addr, heap_size, granule, coalesce, order, track)
+                            : make_allocator<size_t>(policy, base_addr, heap_size, granule, coalesce, order, track);
 
-        case Policy::WorstFit:
-            allocator = std::make_unique<AllocatorWorst>(base_addr, heap_size, coalesce, order);
+    if (threshold > 0) {
+        allocator = std::make_unique<AllocatorBypass>(std::move(allocator), base_addr, heap_size,
+                                                      page_size, region_size, threshold);
+    }
 
-        case Policy::FirstFit:
-            allocator = std::make_unique<AllocatorFirst>(base_addr, heap_size, coalesce, order);
-            break;
+    if (!load_path.empty()) {
+        allocator->restore_state(snapshot.state);
+        allocator->print_status();
+    }
 
-        case Policy::NextFit:
-            allocator = std::make_unique<AllocatorNext>(base_addr, heap_size, coalesce, order);
-            break;
+    std::unique_ptr<Compactor> compactor = nullptr;
+    if (compact_budget > 0) {
+        compactor = std::make_unique<Compactor>(*allocator, compact_budget);
+        for (size_t idx = 0; idx < snapshot.allocated.size(); ++idx) {
+            if (snapshot.freed.find(idx) == snapshot.freed.end()) {
+                compactor->track(idx, snapshot.allocated[idx]);
+            }
+        }
+    }
+
+    exec_memops(ops, *allocator, snapshot.allocated, snapshot.freed, snapshot.marks, compactor.get(), quiet);
+
+    if (!save_path.empty()) {
+        snapshot.state = allocator->save_state();
+        if (!save_snapshot(save_path, snapshot)) {
+            ::exit(EXIT_FAILURE);
+        }
+        std::printf("Snapshot saved to %s\n", save_path.c_str());
     }
 
-    exec_memops(ops, std::forward<std::unique_ptr<Allocator>>(allocator));
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,261 @@
+// snapshot.cc
+// Allocator state snapshot and restore implementation
+// Author: Hank Bao
+
+#include "snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "allocator_bypass.h"
+
+// File layout, all fields are native endian:
+//   SnapshotHeader
+//   FreeRecord[freelist]   free chunks in list order
+//   FreeRecord[extents]    extents mapped by the large-allocation bypass
+//   AllocRecord[allocated] allocations in mem-op order
+//   MarkRecord[heap_marks] tops of open regions in the allocator
+//   MarkRecord[marks]      allocation indices where open regions start
+namespace {
+
+const char kMagic[8] = {'C', 'S', '5', '6', 'S', 'N', 'A', 'P'};
+const uint32_t kVersion = 6;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t order;
+    uint64_t base;
+    uint64_t size;
+    uint64_t policy;
+    uint64_t coalesce;
+    uint64_t track;
+    uint64_t granule;
+    uint64_t threshold;
+    uint64_t page;
+    uint64_t region;
+    uint64_t cursor;
+    uint64_t freelist;
+    uint64_t extents;
+    uint64_t allocated;
+    uint64_t heap_marks;
+    uint64_t marks;
+};
+
+struct FreeRecord {
+    uint64_t base;
+    uint64_t size;
+};
+
+struct AllocRecord {
+    uint64_t base;
+    uint64_t size;
+    uint64_t freed;
+};
+
+struct MarkRecord {
+    uint64_t value;
+};
+
+auto in_range(uint64_t base, uint64_t size, uint64_t start, uint64_t length) -> bool {
+    return base >= start && size <= length && base - start <= length - size;
+}
+
+auto in_heap(const Snapshot& snapshot, uint64_t base, uint64_t size) -> bool {
+    return in_range(base, size, snapshot.base, snapshot.size);
+}
+
+auto in_region(const Snapshot& snapshot, uint64_t base, uint64_t size) -> bool {
+    if (snapshot.threshold == 0) {
+        return false;
+    }
+    auto start = AllocatorBypass::region_base(snapshot.base, snapshot.size, snapshot.page);
+    return in_range(base, size, start, snapshot.region);
+}
+
+}  // namespace
+
+auto save_snapshot(const std::string& path, const Snapshot& snapshot) -> bool {
+    auto fp = std::fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        std::fprintf(stderr, "Failed to open snapshot for writing: %s\n", path.c_str());
+        return false;
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.order = static_cast<uint32_t>(snapshot.order);
+    header.base = snapshot.base;
+    header.size = snapshot.size;
+    header.policy = static_cast<uint64_t>(snapshot.policy);
+    header.coalesce = snapshot.coalesce ? 1 : 0;
+    header.track = snapshot.track ? 1 : 0;
+    header.granule = snapshot.granule;
+    header.threshold = snapshot.threshold;
+    header.page = snapshot.page;
+    header.region = snapshot.region;
+    header.cursor = snapshot.state.cursor;
+    header.freelist = snapshot.state.freelist.size();
+    header.extents = snapshot.state.extents.size();
+    header.allocated = snapshot.allocated.size();
+    header.heap_marks = snapshot.state.marks.size();
+    header.marks = snapshot.marks.size();
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    for (const auto& chunk : snapshot.state.freelist) {
+        FreeRecord record{chunk.base(), chunk.size()};
+        ok = ok && std::fwrite(&record, sizeof(record), 1, fp) == 1;
+    }
+
+    for (const auto& chunk : snapshot.state.extents) {
+        FreeRecord record{chunk.base(), chunk.size()};
+        ok = ok && std::fwrite(&record, sizeof(record), 1, fp) == 1;
+    }
+
+    for (size_t idx = 0; idx < snapshot.allocated.size(); ++idx) {
+        const auto& chunk = snapshot.allocated[idx];
+        AllocRecord record{chunk.base(), chunk.size(), snapshot.freed.count(idx)};
+        ok = ok && std::fwrite(&record, sizeof(record), 1, fp) == 1;
+    }
+
+    for (auto mark : snapshot.state.marks) {
+        MarkRecord record{mark};
+        ok = ok && std::fwrite(&record, sizeof(record), 1, fp) == 1;
+    }
+
+    for (auto mark : snapshot.marks) {
+        MarkRecord record{mark};
+        ok = ok && std::fwrite(&record, sizeof(record), 1, fp) == 1;
+    }
+
+    ok = (std::fclose(fp) == 0) && ok;
+    if (!ok) {
+        std::fprintf(stderr, "Failed to write snapshot: %s\n", path.c_str());
+    }
+    return ok;
+}
+
+auto load_snapshot(const std::string& path, Snapshot& snapshot) -> bool {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "Failed to open snapshot: %s\n", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        std::fprintf(stderr, "Invalid snapshot: %s\n", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    auto length = static_cast<size_t>(st.st_size);
+    auto addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping stays valid after closing
+    if (addr == MAP_FAILED) {
+        std::fprintf(stderr, "Failed to map snapshot: %s\n", path.c_str());
+        return false;
+    }
+
+    auto bytes = static_cast<const char*>(addr);
+    auto header = reinterpret_cast<const SnapshotHeader*>(bytes);
+    auto records = bytes + sizeof(SnapshotHeader);
+
+    bool ok = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+              header->version == kVersion &&
+              header->order <= static_cast<uint32_t>(ListOrder::SizeSortDesc) &&
+              header->policy <= static_cast<uint64_t>(Policy::Region) &&
+              (header->policy == static_cast<uint64_t>(Policy::NextFit) || header->cursor == 0) &&
+              header->granule > 0 && header->size % header->granule == 0 &&
+              (header->threshold == 0 || header->page > 0) &&
+              header->freelist <= length / sizeof(FreeRecord) &&
+              header->extents <= length / sizeof(FreeRecord) &&
+              header->allocated <= length / sizeof(AllocRecord) &&
+              header->heap_marks <= length / sizeof(MarkRecord) &&
+              header->marks <= length / sizeof(MarkRecord) &&
+              length == sizeof(SnapshotHeader) +
+                            (header->freelist + header->extents) * sizeof(FreeRecord) +
+                            header->allocated * sizeof(AllocRecord) +
+                            (header->heap_marks + header->marks) * sizeof(MarkRecord);
+
+    if (ok) {
+        snapshot.base = header->base;
+        snapshot.size = header->size;
+        snapshot.policy = static_cast<Policy>(header->policy);
+        snapshot.coalesce = header->coalesce != 0;
+        snapshot.track = header->track != 0;
+        snapshot.granule = header->granule;
+        snapshot.order = static_cast<ListOrder>(header->order);
+        snapshot.threshold = header->threshold;
+        snapshot.page = header->page;
+        snapshot.region = header->region;
+        snapshot.state.cursor = header->cursor;
+
+        snapshot.state.freelist.clear();
+        snapshot.state.freelist.reserve(header->freelist);
+        auto free_records = reinterpret_cast<const FreeRecord*>(records);
+        for (uint64_t i = 0; ok && i < header->freelist; ++i) {
+            const auto& record = free_records[i];
+            ok = in_heap(snapshot, record.base, record.size) &&
+                 (record.base - snapshot.base) % snapshot.granule == 0 &&
+                 record.size % snapshot.granule == 0;
+            snapshot.state.freelist.emplace_back(record.base, record.size);
+        }
+
+        snapshot.state.extents.clear();
+        snapshot.state.extents.reserve(header->extents);
+        auto extent_records = free_records + header->freelist;
+        for (uint64_t i = 0; ok && i < header->extents; ++i) {
+            const auto& record = extent_records[i];
+            ok = in_region(snapshot, record.base, record.size);
+            snapshot.state.extents.emplace_back(record.base, record.size);
+        }
+
+        snapshot.allocated.clear();
+        snapshot.freed.clear();
+        snapshot.allocated.reserve(header->allocated);
+        auto alloc_records = reinterpret_cast<const AllocRecord*>(
+            records + (header->freelist + header->extents) * sizeof(FreeRecord));
+        for (uint64_t i = 0; ok && i < header->allocated; ++i) {
+            const auto& record = alloc_records[i];
+            ok = in_heap(snapshot, record.base, record.size) ||
+                 in_region(snapshot, record.base, record.size);
+            snapshot.allocated.emplace_back(record.base, record.size);
+            if (record.freed != 0) {
+                snapshot.freed.insert(i);
+            }
+        }
+
+        snapshot.state.marks.clear();
+        snapshot.state.marks.reserve(header->heap_marks);
+        auto heap_mark_records = reinterpret_cast<const MarkRecord*>(
+            reinterpret_cast<const char*>(alloc_records) + header->allocated * sizeof(AllocRecord));
+        for (uint64_t i = 0; ok && i < header->heap_marks; ++i) {
+            ok = in_heap(snapshot, heap_mark_records[i].value, 0);
+            snapshot.state.marks.push_back(heap_mark_records[i].value);
+        }
+
+        snapshot.marks.clear();
+        snapshot.marks.reserve(header->marks);
+        auto mark_records = heap_mark_records + header->heap_marks;
+        for (uint64_t i = 0; ok && i < header->marks; ++i) {
+            ok = mark_records[i].value <= header->allocated;
+            snapshot.marks.push_back(mark_records[i].value);
+        }
+    }
+
+    ::munmap(addr, length);
+
+    if (!ok) {
+        std::fprintf(stderr, "Invalid snapshot: %s\n", path.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,40 @@
+// snapshot.h
+// Allocator state snapshot and restore
+// Author: Hank Bao
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "allocator.h"
+#include "chunk.h"
+
+// A checkpoint of a simulation: heap settings, allocator state and the
+// allocations made by mem-ops so far.
+struct Snapshot {
+    size_t base;
+    size_t size;
+    Policy policy;
+    bool coalesce;
+    bool track;  // tracked frees of the region policy
+    ListOrder order;
+    size_t granule;
+
+    // large-allocation bypass, disabled when threshold is 0
+    size_t threshold;
+    size_t page;
+    size_t region;
+
+    AllocatorState state;
+    std::vector<Chunk> allocated;  // indexed by mem-op alloc order
+    std::set<size_t> freed;        // indices of freed allocations
+    std::vector<size_t> marks;     // indices where open regions start
+};
+
+// Write the snapshot into a binary file, returns false on error
+auto save_snapshot(const std::string& path, const Snapshot& snapshot) -> bool;
+
+// Map the binary file and load the snapshot from it, returns false on error
+auto load_snapshot(const std::string& path, Snapshot& snapshot) -> bool;